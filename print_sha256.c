@@ -2,6 +2,8 @@
 
 short use_colors = 1;
 
+FILE *v_out;
+
 void print_separator(const char c, short width) {
     for (int i = 0; i < width; i++) {
         putc(c, v_out);
@@ -17,7 +19,7 @@ void print_utf8_separator(const char *c, short width) {
 }
 
 /* Print constants (verbose mode) */
-void print_constants(uint32_t constants[]) {
+void print_constants(const uint32_t constants[]) {
     fprintf(v_out, "%s=== Set constants (sixty-four constant 32-bit words)", CYELLOW);
     print_separator('=', 28);
     fprintf(v_out, "%s", CRST);
@@ -120,18 +122,18 @@ void print_in_big_endian(uint8_t *p, size_t length, short table_column) {
     }
 }
 
-void print_padding_block(unsigned char *block, short read, uint64_t message_length) {
+void print_padding_block(unsigned char *block, short bits, uint64_t message_length) {
     char label[100];
-    snprintf(label, 100, "\n=== Padding block (message length: %llu-bit) %c",
+    snprintf(label, 100, "\n=== Padding block (message length: %" PRIu64 "-bit) %c",
              message_length, '\0');
     fprintf(v_out, "%s%s", CYELLOW, label);
     //int8_t length = 
     //fprintf(v_out, "strlen(label) : %lu", strlen(label));
     print_separator('=', 80 - strlen(label) +1);
     fprintf(v_out, "%s", CRST);
-    fprintf(v_out, "%-8s%d-bit\n", "From", read);
+    fprintf(v_out, "%-8s%d-bit\n", "From", bits);
     fprintf(v_out, "---\n");
-    print_hex((uint8_t *)block, read, 16, 1, 1);
+    print_hex((uint8_t *)block, (bits + 7) / 8, 16, 1, 1);
     fprintf(v_out, "\n");
 }
 
@@ -158,17 +160,17 @@ void print_round_work_vars(word_t t1, word_t t2, word_t work_vars[8], int t) {
     fprintf(v_out, "\n");
 }
 
-void print_program_start(char *path, size_t file_size) {
+void print_program_start(char *path, uint64_t file_size) {
     fprintf(v_out, "\n\n%s", CYELLOW);
     print_separator('=', 80);
     fprintf(v_out, "%sSHA-256 Digest Algorithm From Scratch\n%s", "", "");
     print_separator('=', 80);
     fprintf(v_out, "%s\n", CRST);
-    fprintf(v_out, "Input file: %s (%ld bytes)\n\n", path, file_size);
+    fprintf(v_out, "Input file: %s (%" PRIu64 " bytes)\n\n", path, file_size);
 }
 
-void print_result(char *path, word_t hash_computation[], size_t file_size, char result[64],
-                  size_t blocks_processed, double elapsed_ms) {
+void print_result(char *path, word_t hash_computation[], uint64_t file_size, char result[65],
+                  uint64_t blocks_processed, double elapsed_ms) {
     // Print result
     fprintf(v_out, "\n");
     fprintf(v_out, "╔");
@@ -180,13 +182,15 @@ void print_result(char *path, word_t hash_computation[], size_t file_size, char
     fprintf(v_out, "╣\n");
 
     fprintf(v_out, "║ File: %-71s║\n", path);
-    char size_label[40];
+    char size_label[64];
     if (file_size > 1024 * 1024) {
-        snprintf(size_label, 40, "%ld Mb (%ld bytes)", file_size / (1024 * 1024), file_size);
+        snprintf(size_label, sizeof(size_label), "%" PRIu64 " Mb (%" PRIu64 " bytes)",
+                 file_size / (1024 * 1024), file_size);
     } else if (file_size > 1024) {
-        snprintf(size_label, 40, "%ld Kb (%ld bytes)", file_size / 1024, file_size);
+        snprintf(size_label, sizeof(size_label), "%" PRIu64 " Kb (%" PRIu64 " bytes)",
+                 file_size / 1024, file_size);
     } else {
-        snprintf(size_label, 40, "%ld bytes", file_size);
+        snprintf(size_label, sizeof(size_label), "%" PRIu64 " bytes", file_size);
     }
 
     fprintf(v_out, "║ Size: %-71s║\n", size_label);
@@ -211,7 +215,7 @@ void print_result(char *path, word_t hash_computation[], size_t file_size, char
     fprintf(v_out, "╝\n\n");
 
     fprintf(v_out, "  Computation completed successfully\n");
-    fprintf(v_out, "  Processed: %zu block(s)\n", blocks_processed);
+    fprintf(v_out, "  Processed: %" PRIu64 " block(s)\n", blocks_processed);
 
     fprintf(v_out, "  Time spent: %.3f seconds\n\n", elapsed_ms);
 }
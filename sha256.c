@@ -20,69 +20,58 @@
  * SOFTWARE.
  */
 
-#include "print_sha256.h"
+// O_DIRECT and 64-bit off_t on 32-bit builds
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include "sha256_daemon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
-// SHA-256 read the input data in chunks of 64 bytes (512-bit)
-#define MESSAGE_BLOCK_SIZE 64
-
 // The limit after which the padding requires a complete new block
 #define MAX_INCOMPLETE_MESSAGE_BLOCK 56
 
-#define HASH_SIZE 32
-
 #define VERBOSE_CONSOLE_MAX_SIZE (1024) // 1 KB
 
 #define VERBOSE_LOG_FILE_MAX_SIZE (1024 * 100) // 100 KB
 
+// Read buffer, the only memory used for the file whatever its size
+#define READ_BUFFER_SIZE (1024 * 1024) // 1 MB
+
+// Alignment of buffer (and so of offsets and sizes) required by O_DIRECT
+#define DIRECT_IO_ALIGNMENT 4096
+
 short verbose = 0;
 short use_log_file = 0;
 
+// Read bypassing the page cache (O_DIRECT), or drop the pages once hashed
+short direct_io = 0;
+short drop_page_cache = 0;
+
 const int primes[] = {2,   3,   5,   7,   11,  13,  17,  19,  23,  29,  31,  37,  41,
                       43,  47,  53,  61,  67,  71,  73,  79,  83,  89,  97,  101, 103,
                       107, 109, 113, 127, 131, 137, 139, 149, 151, 157, 163, 167, 173,
                       179, 181, 191, 193, 197, 199, 211, 223, 227, 229, 233, 239, 241,
                       251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311};
 
-static uint32_t constants[64];
-
 static uint64_t tot_message_bits;
 
-static size_t blocks_processed = 0;
+static uint64_t blocks_processed = 0;
 
 static word_t hash_computation[8];
 
-static char result[64];
-
-void set_constants() {
-    /* Pre-computed SHA-256 K constants (first 32 bits of fractional parts of
-     * cube roots of first 64 primes) */
-    const unsigned int K[64] = {
-        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
-        0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
-        0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
-        0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
-        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
-        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
-        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
-        0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
-        0xc67178f2};
-
-    memcpy(constants, K, sizeof(K));
-}
+static char result[HASH_SIZE * 2 + 1];
 
 void set_initial_hashvalue(word_t work_vars[8]) {
-    /* Pre-computed SHA-256 initial hash values (first 32 bits of fractional
-     * parts of square roots of first 8 primes */
-    const unsigned int H[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-                               0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
-
-    memcpy(work_vars, H, sizeof(H));
+    memcpy(work_vars, sha256_h0, sizeof(sha256_h0));
 
     if (verbose) {
         print_init_hash_values(work_vars);
@@ -229,7 +218,7 @@ void elab_block(unsigned char *message_block, word_t prev_hash_computation[8], s
         word_t t1, t2;
 
         t1 = work_vars[7] + sum_op_1(work_vars[4]) +
-             ch_op(work_vars[4], work_vars[5], work_vars[6]) + constants[t] + words[t];
+             ch_op(work_vars[4], work_vars[5], work_vars[6]) + sha256_k[t] + words[t];
         t2 = sum_op_0(work_vars[0]) + maj_op(work_vars[0], work_vars[1], work_vars[2]);
         work_vars[7] = work_vars[6];
         work_vars[6] = work_vars[5];
@@ -255,27 +244,43 @@ void elab_block(unsigned char *message_block, word_t prev_hash_computation[8], s
     }
 
     for (int i = 0; i < 8; i++) {
-        fprintf(v_out, "H%d  ", i);
         if (verbose) {
+            fprintf(v_out, "H%d  ", i);
             print_in_big_endian((uint8_t *)&prev_hash_computation[i], 4, 1);
         }
         prev_hash_computation[i] = work_vars[i] + prev_hash_computation[i];
-        fprintf(v_out, "  ->  ");
         if (verbose) {
+            fprintf(v_out, "  ->  ");
             print_in_big_endian((uint8_t *)&prev_hash_computation[i], 4, 1);
+            fprintf(v_out, "\n");
         }
-        fprintf(v_out, "\n");
     }
 
     if (verbose && !last_block) {
         fprintf(v_out, "%s\n=== Block processing complete", CYELLOW);
         print_separator('=', 51);
         fprintf(v_out, "%s", CRST);
-        print_in_big_endian((uint8_t *)hash_computation, HASH_SIZE, 0);
+        print_in_big_endian((uint8_t *)prev_hash_computation, HASH_SIZE, 0);
         fprintf(v_out, "\n\n");
     }
 }
 
+/**
+ * Sets the '1' bit that ends the message right after its last bit and zeroes
+ * the rest of the block.
+ *
+ * Parameters
+ *      bits                Message bits in the block (0-511)
+ */
+void append_end_bit(unsigned char *block, int bits) {
+    int byte = bits / 8;
+    int bit = bits % 8;
+
+    // Keep the first 'bit' bits of the last incomplete byte
+    block[byte] = (block[byte] & (uint8_t)(0xFF00 >> bit)) | (0x80 >> bit);
+    memset(block + byte + 1, 0, MESSAGE_BLOCK_SIZE - byte - 1);
+}
+
 /**
  * Additional paramters indicates that the block was added due to insufficient
  * space in last block to put the last 4-byte big-endian message length.
@@ -285,21 +290,20 @@ void elab_block(unsigned char *message_block, word_t prev_hash_computation[8], s
  * Writes to the last 4-byte the message size in big-endian
  *
  * Parameters
- *      read                Tot read bytes of last incomplete block.
+ *      bits                Message bits of last incomplete block.
  *      message_length      Total bits read, to put in bit-endian in last
  * 4-bytes
  */
-void padding_block(unsigned char *block, int read, uint64_t message_length, uint8_t additional) {
+void padding_block(unsigned char *block, int bits, uint64_t message_length, uint8_t additional) {
     if (verbose) {
-        print_padding_block(block, read, message_length);
+        print_padding_block(block, bits, message_length);
     }
 
     // case of additional padding block
     if (additional) {
         memset(block, 0, MESSAGE_BLOCK_SIZE);
     } else {
-        block[read] = 0x80;
-        memset(block + read + 1, 0, MESSAGE_BLOCK_SIZE - read - 1);
+        append_end_bit(block, bits);
     }
 
     // Pointer to the last 8 bytes (64-bit)
@@ -322,53 +326,195 @@ void padding_block(unsigned char *block, int read, uint64_t message_length, uint
     }
 }
 
-/* Read file blocks for elaboration (64 bytes - 512 bits for SHA-256) */
-void sha256(FILE *fp) {
-    unsigned char buff[MESSAGE_BLOCK_SIZE]; // 512-bit
-    int read;
+/**
+ * Elaborates a block holding 'bits' bits of the message, adding the padding
+ * when the block is incomplete (0 bits for the padding of a message multiple
+ * of 512-bit).
+ *
+ * Returns the number of elaborated blocks: 2 when the message length does
+ * not fit in the block and the padding requires an additional one.
+ */
+int process_block(unsigned char *block, int bits, uint64_t message_length, word_t hash[8]) {
+    uint8_t new_padding_block = 0;
 
-    set_constants();
-    if(verbose) {
-        print_constants(constants);
+    /* Fill the padding in current block */
+    if (bits < MAX_INCOMPLETE_MESSAGE_BLOCK * 8) {
+        padding_block(block, bits, message_length, 0);
+    }
+    /* Create a new emty block for the padding */
+    else if (bits < MESSAGE_BLOCK_SIZE * 8) {
+        append_end_bit(block, bits);
+        new_padding_block = 1;
+    }
+
+    elab_block(block, hash, bits != MESSAGE_BLOCK_SIZE * 8);
+
+    if (new_padding_block) {
+        unsigned char new_block[MESSAGE_BLOCK_SIZE];
+        padding_block(new_block, 0, message_length, 1);
+        elab_block(new_block, hash, 1);
     }
-    
+
+    return 1 + new_padding_block;
+}
+
+/* Hash a message of 'bits' bits (any length, not only whole bytes) held in
+ * memory, with the same block elaboration used for files */
+void sha256_bits(const uint8_t *message, uint64_t bits, word_t hash[8]) {
+    unsigned char block[MESSAGE_BLOCK_SIZE];
+    uint64_t offset = 0;
+
+    memcpy(hash, sha256_h0, sizeof(sha256_h0));
+
+    while (offset < bits) {
+        int block_bits = bits - offset < MESSAGE_BLOCK_SIZE * 8 ? bits - offset
+                                                                : MESSAGE_BLOCK_SIZE * 8;
+        memcpy(block, message + offset / 8, (block_bits + 7) / 8);
+        offset += block_bits;
+        process_block(block, block_bits, bits, hash);
+    }
+
+    if (bits % (MESSAGE_BLOCK_SIZE * 8) == 0) {
+        process_block(block, 0, bits, hash);
+    }
+}
+
+/* Read until the buffer is full or the end of file, returns -1 on error.
+ * With offset -1 reads from the current position (pipes) */
+ssize_t read_full(int fd, unsigned char *buff, size_t size, off_t offset) {
+    size_t got = 0;
+
+    while (got < size) {
+        ssize_t n = offset < 0 ? read(fd, buff + got, size - got)
+                               : pread(fd, buff + got, size - got, offset + got);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        got += n;
+    }
+
+    return got;
+}
+
+/**
+ * Read file blocks for elaboration (64 bytes - 512 bits for SHA-256).
+ *
+ * The file is read in chunks of READ_BUFFER_SIZE, so the memory used does
+ * not depend on the file size. Only the first 'max_bits' bits of the file
+ * are hashed, the last byte may be incomplete (UINT64_MAX for the whole
+ * file).
+ *
+ * Seekable files are read with pread() from the start, whatever their
+ * offset, which is left unchanged (descriptors shared with another process,
+ * as those passed to the daemon); pipes are read from where they are.
+ *
+ * Besides the parameters it only reads the verbose, direct_io and
+ * drop_page_cache settings and stores the progress in progress_bytes, so
+ * with verbose off files can be hashed on several threads at once. Hashed
+ * bits and elaborated blocks are added to message_bits and blocks.
+ *
+ * Returns 0, or -1 with errno set on read errors.
+ */
+int sha256_fd(int fd, uint64_t max_bits, word_t hash[8], uint64_t *message_bits,
+              uint64_t *blocks) {
+    unsigned char *buff; // READ_BUFFER_SIZE / 64 blocks of 512-bit
+    uint64_t remaining_bits = max_bits;
+    uint64_t offset = 0;
+    off_t position = lseek(fd, 0, SEEK_CUR) < 0 ? -1 : 0; // of pread(), -1 on pipes
+    ssize_t read = 0;
+
+    if (posix_memalign((void **)&buff, DIRECT_IO_ALIGNMENT, READ_BUFFER_SIZE) != 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (!direct_io) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
     /* preprocess */
-    set_initial_hashvalue(hash_computation);
-
-    while ((read = fread(buff, 1, sizeof(buff), fp)) > 0) {
-        blocks_processed++;
-        tot_message_bits += read;
-        
-        if(verbose) {
-            fprintf(v_out, "%s=== Start processing block %zu ", CYELLOW, blocks_processed);
-            print_separator('=', 51);
-            fprintf(v_out, "%s", CRST);
-            fprintf(v_out, "Processing %d bytes at offset %ld\n", read, ftell(fp));
+    set_initial_hashvalue(hash);
+
+    /* With O_DIRECT the whole buffer is always requested, the bits after
+     * max_bits are ignored */
+    while (remaining_bits > 0 && (read = read_full(fd, buff, READ_BUFFER_SIZE, position)) > 0) {
+        if (drop_page_cache) {
+            posix_fadvise(fd, offset, read, POSIX_FADV_DONTNEED);
         }
 
-        uint8_t new_padding_block = 0;
+        for (ssize_t i = 0; i < read && remaining_bits > 0; i += MESSAGE_BLOCK_SIZE) {
+            int bytes = read - i < MESSAGE_BLOCK_SIZE ? read - i : MESSAGE_BLOCK_SIZE;
+            int bits = (uint64_t)bytes * 8 < remaining_bits ? bytes * 8 : (int)remaining_bits;
+
+            remaining_bits -= bits;
+            *message_bits += bits;
 
-        /* Fill the padding in current block */
-        if (read < MAX_INCOMPLETE_MESSAGE_BLOCK) {
-            padding_block(buff, read, tot_message_bits * 8, 0);
+            if(verbose) {
+                fprintf(v_out, "%s=== Start processing block %" PRIu64 " ", CYELLOW,
+                        *blocks + 1);
+                print_separator('=', 51);
+                fprintf(v_out, "%s", CRST);
+                fprintf(v_out, "Processing %d bits at offset %" PRIu64 "\n", bits,
+                        offset + i);
+            }
+
+            *blocks += process_block(buff + i, bits, *message_bits, hash);
         }
-        /* Create a new emty block for the padding */
-        else if (read < MESSAGE_BLOCK_SIZE && (read + 1) >= MAX_INCOMPLETE_MESSAGE_BLOCK) {
-            buff[read] = 0x80;
-            memset(buff + read + 1, 0, MESSAGE_BLOCK_SIZE - read - 1);
-            new_padding_block = 1;
+
+        offset += read;
+        if (position >= 0) {
+            position = offset;
         }
 
-        elab_block(buff, hash_computation, read != MESSAGE_BLOCK_SIZE);
+        /* Bytes actually hashed, the last chunk may go past max_bits. Only
+         * the reporter thread reads it, no ordering required */
+        atomic_store_explicit(&progress_bytes, (max_bits - remaining_bits + 7) / 8,
+                              memory_order_relaxed);
 
-        if (new_padding_block) {
-            unsigned char new_block[MESSAGE_BLOCK_SIZE];
-            padding_block(new_block, 0, tot_message_bits * 8, 1);
-            elab_block(new_block, hash_computation, 1);
+        if (read < READ_BUFFER_SIZE) {
+            break;
         }
+    }
+
+    if (read < 0) {
+        int error = errno;
+        free(buff);
+        errno = error;
+        return -1;
+    }
+
+    /* Message length multiple of 512-bit (or empty): the padding needs a
+     * block on its own */
+    if (*message_bits % (MESSAGE_BLOCK_SIZE * 8) == 0) {
+        *blocks += process_block(buff, 0, *message_bits, hash);
+    }
+
+    free(buff);
+
+    return 0;
+}
+
+/* Hash the file into the program state, then format the result */
+void sha256(int fd, uint64_t max_bits) {
+    if(verbose) {
+        print_constants(sha256_k);
+    }
+
+    if (sha256_fd(fd, max_bits, hash_computation, &tot_message_bits, &blocks_processed) != 0) {
+        perror("Error reading the file");
+        exit(EXIT_FAILURE);
+    }
 
-        /* Clean buffer */
-        memset(buff, 0, MESSAGE_BLOCK_SIZE);
+    /* Sizes of pipes are not known in advance, -bits is checked here */
+    if (max_bits != UINT64_MAX && tot_message_bits < max_bits) {
+        fprintf(stderr, "Error: File has only %" PRIu64 " bits\n", tot_message_bits);
+        exit(EXIT_FAILURE);
     }
 
     FILE *stream = fmemopen(result, sizeof(result), "w");
@@ -390,17 +536,75 @@ void sha256(FILE *fp) {
     fprintf(v_out, "%s", CRST);
 }
 
-long get_file_size(FILE *file) {
-    long size;
+/**
+ * Size from the file metadata, or from the end offset for block devices
+ * (their position is restored).
+ *
+ * Returns 0, or -1 if the size is not known (pipes, terminals), with size 0.
+ */
+int get_file_size(int fd, uint64_t *size) {
+    struct stat st;
+
+    *size = 0;
 
-    long current_pos = ftell(file);
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
 
-    fseek(file, 0, SEEK_END);
-    size = ftell(file);
-    // Restore original position
-    fseek(file, current_pos, SEEK_SET);
+    if (S_ISREG(st.st_mode)) {
+        *size = (uint64_t)st.st_size;
+        return 0;
+    }
+
+    if (S_ISBLK(st.st_mode)) {
+        off_t current_pos = lseek(fd, 0, SEEK_CUR);
+        off_t end = lseek(fd, 0, SEEK_END);
+        if (current_pos < 0 || end < 0) {
+            return -1;
+        }
+        lseek(fd, current_pos, SEEK_SET);
+        *size = (uint64_t)end;
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * Opens the file for reading, with O_DIRECT if requested. When the file
+ * system does not support it, falls back to dropping the pages from the
+ * cache once hashed.
+ */
+int open_input(const char *path) {
+#ifdef O_DIRECT
+    if (direct_io) {
+        int fd = open(path, O_RDONLY | O_DIRECT);
+        if (fd >= 0 || errno != EINVAL) {
+            return fd;
+        }
+        fprintf(stderr, "O_DIRECT not supported, pages will be dropped from the cache\n");
+    }
+#endif
+    if (direct_io) {
+        direct_io = 0;
+        drop_page_cache = 1;
+    }
+
+    return open(path, O_RDONLY);
+}
 
-    return size;
+void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s <file> [-v|-verbose]\n", program);
+    fprintf(stderr, "       %s <file> -bits <n>\n", program);
+    fprintf(stderr, "       %s <file> -d|-direct\n", program);
+    fprintf(stderr, "       %s <file> -p|-progress\n", program);
+    fprintf(stderr, "       %s -b|-bench <leaves>\n", program);
+    fprintf(stderr, "       %s -t|-cavp <file.rsp> [-t|-cavp <file.rsp> ...]\n", program);
+    fprintf(stderr, "       %s -s|-daemon <socket> [-workers <n>]\n", program);
+    fprintf(stderr, "       %s <file> -c|-connect <socket>\n", program);
+    fprintf(stderr,
+            "       %s -L|-loadtest <socket> [-clients <n>] [-requests <n>] [-size <bytes>]\n",
+            program);
 }
 
 int main(int argc, char **argv) {
@@ -409,36 +613,155 @@ int main(int argc, char **argv) {
     start = clock();
 
     char *path = NULL;
+    size_t bench_leaves = 0;
+    uint64_t message_bits = UINT64_MAX;
+    short progress = 0;
+    const char *cavp_files[argc];
+    int cavp_count = 0;
+    const char *daemon_socket = NULL;
+    const char *connect_socket = NULL;
+    const char *loadtest_socket = NULL;
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    long clients = 8;
+    long requests = 1000;
+    long request_size = 64;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "-verbose") == 0) {
             verbose = 1;
+        } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "-bench") == 0) {
+            if (i + 1 >= argc || (bench_leaves = strtoull(argv[++i], NULL, 10)) < 2) {
+                fprintf(stderr, "Error: Benchmark requires at least 2 leaves\n");
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "-progress") == 0) {
+            progress = 1;
+        } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "-direct") == 0) {
+            direct_io = 1;
+        } else if (strcmp(argv[i], "-bits") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing message length in bits\n");
+                print_usage(argv[0]);
+                return 1;
+            }
+            message_bits = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "-cavp") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing CAVP response file\n");
+                print_usage(argv[0]);
+                return 1;
+            }
+            cavp_files[cavp_count++] = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "-daemon") == 0 ||
+                   strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "-connect") == 0 ||
+                   strcmp(argv[i], "-L") == 0 || strcmp(argv[i], "-loadtest") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing daemon socket path\n");
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (argv[i][1] == 's' || strcmp(argv[i], "-daemon") == 0) {
+                daemon_socket = argv[++i];
+            } else if (argv[i][1] == 'c') {
+                connect_socket = argv[++i];
+            } else {
+                loadtest_socket = argv[++i];
+            }
+        } else if (strcmp(argv[i], "-workers") == 0 || strcmp(argv[i], "-clients") == 0 ||
+                   strcmp(argv[i], "-requests") == 0 || strcmp(argv[i], "-size") == 0) {
+            long value = i + 1 < argc ? strtol(argv[i + 1], NULL, 10) : -1;
+            long min = strcmp(argv[i], "-size") == 0 ? 0 : 1;
+            long max = INT_MAX;
+            if (strcmp(argv[i], "-size") == 0) {
+                max = DAEMON_MAX_DATA;
+            } else if (strcmp(argv[i], "-workers") == 0) {
+                max = DAEMON_MAX_WORKERS;
+            } else if (strcmp(argv[i], "-clients") == 0) {
+                max = DAEMON_MAX_CLIENTS;
+            }
+            if (value < min || value > max) {
+                fprintf(stderr, "Error: Invalid value for %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (strcmp(argv[i], "-workers") == 0) {
+                workers = value;
+            } else if (strcmp(argv[i], "-clients") == 0) {
+                clients = value;
+            } else if (strcmp(argv[i], "-requests") == 0) {
+                requests = value;
+            } else {
+                request_size = value;
+            }
+            i++;
         } else if (path == NULL) {
             // First non-flag argument is the work directory
             path = argv[i];
         } else {
             // Multiple work directories provided - error
             fprintf(stderr, "Error: Multiple taget file paths provided\n");
-            fprintf(stderr, "Usage: %s <file> [-v|-verbose]\n", argv[0]);
+            print_usage(argv[0]);
             return 1;
         }
     }
 
+    /* Benchmark, test vectors and daemon do not trace the blocks */
+    if (bench_leaves || cavp_count || daemon_socket || loadtest_socket) {
+        verbose = 0;
+    }
+
+    if (daemon_socket) {
+        if (workers > DAEMON_MAX_WORKERS) {
+            workers = DAEMON_MAX_WORKERS;
+        }
+        return run_daemon(daemon_socket, workers > 0 ? workers : 1);
+    }
+
+    if (loadtest_socket) {
+        return run_loadtest(loadtest_socket, clients, requests, request_size);
+    }
+
+    if (bench_leaves) {
+        return bench_merkle(bench_leaves);
+    }
+
+    if (cavp_count) {
+        int status = EXIT_SUCCESS;
+        for (int i = 0; i < cavp_count; i++) {
+            if (run_cavp(cavp_files[i]) != EXIT_SUCCESS) {
+                status = EXIT_FAILURE;
+            }
+        }
+        return status;
+    }
+
     if (path == NULL) {
         fprintf(stderr, "Error: No file paths provided\n");
-        fprintf(stderr, "Usage: %s <file> [-v|-verbose]\n", argv[0]);
+        print_usage(argv[0]);
         return 1;
     }
 
-    FILE *fp = fopen(path, "r");
+    if (connect_socket) {
+        return run_client(connect_socket, path);
+    }
+
+    int fd = open_input(path);
 
-    if (fp == NULL) {
+    if (fd < 0) {
         fprintf(stderr, "Invalid target path\n");
         return 1;
     }
 
     // Set verbose stream: stdout if verbose, /dev/null if not
-    long file_size = get_file_size(fp);
+    uint64_t file_size;
+    short size_known = get_file_size(fd, &file_size) == 0;
+
+    if (size_known && message_bits != UINT64_MAX && message_bits > file_size * 8) {
+        fprintf(stderr, "Error: File has only %" PRIu64 " bits\n", file_size * 8);
+        close(fd);
+        return 1;
+    }
 
     if (verbose && file_size <= VERBOSE_CONSOLE_MAX_SIZE) {
         v_out = stdout;
@@ -460,7 +783,7 @@ int main(int argc, char **argv) {
 
         if (v_out == NULL) {
             fprintf(stderr, "Error on log file %s creation.", logfile);
-            fclose(fp);
+            close(fd);
             exit(EXIT_FAILURE);
         }
 
@@ -485,8 +808,17 @@ int main(int argc, char **argv) {
 
     print_program_start(path,file_size);
 
+    if (progress) {
+        uint64_t message_bytes = message_bits / 8 + (message_bits % 8 != 0);
+        progress_start(message_bytes < file_size ? message_bytes : file_size);
+    }
+
     /* Start algorithm */
-    sha256(fp);
+    sha256(fd, message_bits);
+
+    if (progress) {
+        progress_stop();
+    }
 
     end = clock();
     double elapsed_ms = ((double)(end - start) / CLOCKS_PER_SEC);
@@ -499,7 +831,7 @@ int main(int argc, char **argv) {
 
     print_result(path, hash_computation, file_size, result, blocks_processed, elapsed_ms);
 
-    fclose(fp);
+    close(fd);
 
     return EXIT_SUCCESS;
 }
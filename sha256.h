@@ -0,0 +1,86 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include "print_sha256.h"
+#include <stdatomic.h>
+
+// SHA-256 read the input data in chunks of 64 bytes (512-bit)
+#define MESSAGE_BLOCK_SIZE 64
+
+#define HASH_SIZE 32
+
+/* Pre-computed SHA-256 K constants (first 32 bits of fractional parts of
+ * cube roots of first 64 primes) */
+static const word_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+/* Pre-computed SHA-256 initial hash values (first 32 bits of fractional
+ * parts of square roots of first 8 primes */
+static const word_t sha256_h0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+/* Number of independent messages hashed side by side by the batch functions */
+#define SHA256_LANES 8
+
+void elab_block(unsigned char *message_block, word_t prev_hash_computation[8], short last_block);
+
+void append_end_bit(unsigned char *block, int bits);
+
+void padding_block(unsigned char *block, int bits, uint64_t message_length, uint8_t additional);
+
+int process_block(unsigned char *block, int bits, uint64_t message_length, word_t hash[8]);
+
+void sha256_bits(const uint8_t *message, uint64_t bits, word_t hash[8]);
+
+int sha256_fd(int fd, uint64_t max_bits, word_t hash[8], uint64_t *message_bits,
+              uint64_t *blocks);
+
+/* Serialize the hash value as the 32 bytes of the digest (big-endian words).
+ * Inline, as the fast paths call it for every digest */
+static inline void sha256_digest_bytes(const word_t hash[8], uint8_t digest[HASH_SIZE]) {
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = hash[i] >> 24;
+        digest[i * 4 + 1] = hash[i] >> 16;
+        digest[i * 4 + 2] = hash[i] >> 8;
+        digest[i * 4 + 3] = hash[i];
+    }
+}
+
+/* Fixed-size fast paths (sha256_fast.c), digests are written as 32 bytes */
+
+void sha256_32(const uint8_t in[32], uint8_t out[32]);
+
+void sha256_64(const uint8_t in[64], uint8_t out[32]);
+
+void sha256d_64(const uint8_t in[64], uint8_t out[32]);
+
+void sha256_64_batch(const uint8_t *in, uint8_t *out, size_t n);
+
+void sha256d_64_batch(const uint8_t *in, uint8_t *out, size_t n);
+
+void merkle_root(const uint8_t *leaves, size_t n, uint8_t root[32]);
+
+int bench_merkle(size_t leaves);
+
+/* NIST CAVP response files (sha256_cavp.c) */
+
+int run_cavp(const char *path);
+
+/* Progress reporter thread (sha256_progress.c) */
+
+extern _Atomic uint64_t progress_bytes;
+
+void progress_start(uint64_t total_bytes);
+
+void progress_stop();
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2025 Fabio De Orazi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Runs the NIST CAVP (Cryptographic Algorithm Validation Program) response
+ * files of SHA-256 against every implementation of the algorithm:
+ *
+ *   SHA256ShortMsg.rsp, SHA256LongMsg.rsp   "Len = ", "Msg = ", "MD = " entries,
+ *                                           byte or bit oriented
+ *   SHA256Monte.rsp                         "Seed = " followed by 100
+ *                                           "COUNT = ", "MD = " checkpoints
+ *
+ * The general block functions hash every message, the fast paths of
+ * sha256_fast.c only the messages of their fixed size.
+ */
+
+#include "sha256.h"
+#include <time.h>
+
+#define MONTE_CHECKPOINTS 100
+
+#define MONTE_ITERATIONS 1000
+
+enum { K_GENERIC, K_SHA256_32, K_SHA256_64, K_SHA256_64_BATCH, K_COUNT };
+
+static const char *kernel_names[K_COUNT] = {"generic", "sha256_32", "sha256_64",
+                                            "sha256_64_batch"};
+
+typedef struct {
+    size_t passed;
+    size_t total;
+} kernel_result;
+
+/* Converts 'bytes' bytes of hex text, returns 0 on invalid characters */
+static int parse_hex(const char *hex, uint8_t *out, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        unsigned int byte;
+        if (sscanf(hex + i * 2, "%2x", &byte) != 1) {
+            return 0;
+        }
+        out[i] = byte;
+    }
+    return 1;
+}
+
+static void check(kernel_result results[], int kernel, const uint8_t digest[HASH_SIZE],
+                  const uint8_t expected[HASH_SIZE], uint64_t len) {
+    results[kernel].total++;
+    if (memcmp(digest, expected, HASH_SIZE) == 0) {
+        results[kernel].passed++;
+    } else {
+        fprintf(stderr, "  FAILED %s (Len = %llu)\n", kernel_names[kernel],
+                (unsigned long long)len);
+    }
+}
+
+/* Hash a Len/Msg/MD entry with the kernels that support its length */
+static void run_message(kernel_result results[], const uint8_t *msg, uint64_t len,
+                        const uint8_t expected[HASH_SIZE]) {
+    word_t hash[8];
+    uint8_t digest[HASH_SIZE];
+
+    sha256_bits(msg, len, hash);
+    sha256_digest_bytes(hash, digest);
+    check(results, K_GENERIC, digest, expected, len);
+
+    if (len == 256) {
+        sha256_32(msg, digest);
+        check(results, K_SHA256_32, digest, expected, len);
+    }
+
+    if (len == 512) {
+        sha256_64(msg, digest);
+        check(results, K_SHA256_64, digest, expected, len);
+
+        /* One message in every lane, plus one left for the single path */
+        uint8_t in[(SHA256_LANES + 1) * 64];
+        uint8_t out[(SHA256_LANES + 1) * HASH_SIZE];
+        for (int l = 0; l <= SHA256_LANES; l++) {
+            memcpy(in + l * 64, msg, 64);
+        }
+        sha256_64_batch(in, out, SHA256_LANES + 1);
+        for (int l = 0; l <= SHA256_LANES; l++) {
+            check(results, K_SHA256_64_BATCH, out + l * HASH_SIZE, expected, len);
+        }
+    }
+}
+
+/**
+ * Monte Carlo test: from the seed, every checkpoint chains 1000 hashes of the
+ * last three digests concatenated, and its last digest is the next seed.
+ *
+ * Returns the number of checkpoints read from the file.
+ */
+static int run_monte(FILE *fp, char **line, size_t *cap, const uint8_t seed[HASH_SIZE],
+                     kernel_result *result) {
+    uint8_t md[3][HASH_SIZE];
+    uint8_t message[3 * HASH_SIZE];
+    uint8_t expected[HASH_SIZE];
+    word_t hash[8];
+    int checkpoints = 0;
+    struct timespec start, end;
+
+    memcpy(md[2], seed, HASH_SIZE);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (checkpoints < MONTE_CHECKPOINTS && getline(line, cap, fp) > 0) {
+        if (strncmp(*line, "MD = ", 5) != 0) {
+            continue;
+        }
+        if (!parse_hex(*line + 5, expected, HASH_SIZE)) {
+            fprintf(stderr, "  Invalid MD at checkpoint %d\n", checkpoints);
+            break;
+        }
+
+        memcpy(md[0], md[2], HASH_SIZE);
+        memcpy(md[1], md[2], HASH_SIZE);
+
+        for (int i = 0; i < MONTE_ITERATIONS; i++) {
+            memcpy(message, md, sizeof(message));
+            sha256_bits(message, sizeof(message) * 8, hash);
+            memmove(md[0], md[1], 2 * HASH_SIZE);
+            sha256_digest_bytes(hash, md[2]);
+        }
+
+        result->total++;
+        if (memcmp(md[2], expected, HASH_SIZE) == 0) {
+            result->passed++;
+        } else {
+            fprintf(stderr, "  FAILED generic (checkpoint %d)\n", checkpoints);
+        }
+        checkpoints++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double hashes = (double)checkpoints * MONTE_ITERATIONS;
+
+    printf("  Monte Carlo: %.0f hashes in %.3f seconds (%.0f hashes/s)\n", hashes, seconds,
+           seconds > 0 ? hashes / seconds : 0);
+
+    return checkpoints;
+}
+
+/* Run all the entries of a response file, returns EXIT_FAILURE if any fails */
+int run_cavp(const char *path) {
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Unable to open CAVP file %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    kernel_result results[K_COUNT] = {{0}};
+    char *line = NULL;
+    size_t cap = 0;
+    uint8_t *msg = NULL;
+    uint64_t len = 0;
+    int have_msg = 0; // 1 parsed, -1 invalid (already counted), 0 none
+    size_t malformed = 0;
+
+    printf("%s\n", path);
+
+    while (getline(&line, &cap, fp) > 0) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (strncmp(line, "Len = ", 6) == 0) {
+            len = strtoull(line + 6, NULL, 10);
+            have_msg = 0;
+        } else if (strncmp(line, "Msg = ", 6) == 0) {
+            size_t bytes = (len + 7) / 8;
+            free(msg);
+            msg = malloc(bytes > 0 ? bytes : 1);
+            if (msg == NULL) {
+                fprintf(stderr, "Error: Unable to allocate memory for %zu bytes\n", bytes);
+                exit(EXIT_FAILURE);
+            }
+            have_msg = strlen(line + 6) >= bytes * 2 && parse_hex(line + 6, msg, bytes) ? 1 : -1;
+            if (have_msg < 0) {
+                fprintf(stderr, "  Invalid Msg (Len = %llu)\n", (unsigned long long)len);
+                malformed++;
+            }
+        } else if (strncmp(line, "MD = ", 5) == 0) {
+            uint8_t expected[HASH_SIZE];
+            if (have_msg > 0 && parse_hex(line + 5, expected, HASH_SIZE)) {
+                run_message(results, msg, len, expected);
+            } else if (have_msg >= 0) {
+                fprintf(stderr, "  Invalid MD (Len = %llu)\n", (unsigned long long)len);
+                malformed++;
+            }
+            have_msg = 0;
+        } else if (strncmp(line, "Seed = ", 7) == 0) {
+            uint8_t seed[HASH_SIZE];
+            if (!parse_hex(line + 7, seed, HASH_SIZE)) {
+                fprintf(stderr, "  Invalid Seed\n");
+                malformed++;
+            } else if (run_monte(fp, &line, &cap, seed, &results[K_GENERIC]) <
+                       MONTE_CHECKPOINTS) {
+                fprintf(stderr, "  Monte Carlo: fewer than %d checkpoints\n",
+                        MONTE_CHECKPOINTS);
+                malformed++;
+            }
+        }
+    }
+
+    free(msg);
+    free(line);
+    fclose(fp);
+
+    int status = EXIT_SUCCESS;
+    size_t total = 0;
+
+    for (int k = 0; k < K_COUNT; k++) {
+        if (results[k].total == 0) {
+            continue;
+        }
+        printf("  %-18s%6zu/%-6zu %s\n", kernel_names[k], results[k].passed, results[k].total,
+               results[k].passed == results[k].total ? "passed" : "FAILED");
+        if (results[k].passed != results[k].total) {
+            status = EXIT_FAILURE;
+        }
+        total += results[k].total;
+    }
+
+    /* Entries that could not be run would otherwise go unnoticed */
+    if (malformed > 0) {
+        printf("  %-18s%6zu        FAILED\n", "malformed entries", malformed);
+        status = EXIT_FAILURE;
+    } else if (total == 0) {
+        fprintf(stderr, "  No test vectors found\n");
+        status = EXIT_FAILURE;
+    }
+    printf("\n");
+
+    return status;
+}
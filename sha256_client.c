@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2025 Fabio De Orazi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Client of the hashing daemon: hashes a file passing its descriptor, and
+ * measures the request latency with concurrent clients (load test).
+ */
+
+#include "sha256_daemon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    const char *socket_path;
+    const uint8_t *payload;
+    size_t size;
+    const uint8_t *expected;
+    int requests;
+    double *latencies; // seconds, one per request
+    int completed;
+    int failed;
+} loadtest_client;
+
+int connect_daemon(const char *socket_path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long\n");
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        perror("Error creating the socket");
+        return -1;
+    }
+
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("Error connecting to the daemon");
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/* Hash a file through the daemon and print it like sha256sum */
+int run_client(const char *socket_path, const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        fprintf(stderr, "Invalid target path\n");
+        return EXIT_FAILURE;
+    }
+
+    int sock = connect_daemon(socket_path);
+    if (sock < 0) {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    daemon_response resp;
+    int status = EXIT_FAILURE;
+
+    if (send_request(sock, REQ_HASH_FD, NULL, 0, fd) != 0 ||
+        recv_all(sock, &resp, sizeof(resp)) != sizeof(resp)) {
+        fprintf(stderr, "Error: No response from the daemon\n");
+    } else if (resp.status == RESP_ERROR) {
+        fprintf(stderr, "Error: %s\n", strerror(resp.error));
+    } else if (resp.status != RESP_OK) {
+        fprintf(stderr, "Error: Request rejected by the daemon\n");
+    } else {
+        for (int i = 0; i < HASH_SIZE; i++) {
+            printf("%02x", resp.digest[i]);
+        }
+        printf("  %s\n", path);
+        status = EXIT_SUCCESS;
+    }
+
+    close(sock);
+    close(fd);
+
+    return status;
+}
+
+/* Sends the requests of a client one after the other, timing each of them */
+static void *loadtest_loop(void *arg) {
+    loadtest_client *c = arg;
+    int sock = connect_daemon(c->socket_path);
+
+    if (sock < 0) {
+        c->failed = c->requests;
+        return NULL;
+    }
+
+    for (int r = 0; r < c->requests; r++) {
+        struct timespec start, end;
+        daemon_response resp;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (send_request(sock, REQ_HASH_DATA, c->payload, c->size, -1) != 0 ||
+            recv_all(sock, &resp, sizeof(resp)) != sizeof(resp)) {
+            c->failed += c->requests - r;
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (resp.status != RESP_OK || memcmp(resp.digest, c->expected, HASH_SIZE) != 0) {
+            c->failed++;
+            continue;
+        }
+        c->latencies[c->completed++] =
+            (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+
+    close(sock);
+
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t count, double p) {
+    size_t index = (size_t)(p / 100.0 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+/**
+ * Starts 'clients' threads, each with its own connection sending 'requests'
+ * inline messages of 'size' bytes, and reports latency percentiles and
+ * throughput. Digests are checked against the local computation.
+ */
+int run_loadtest(const char *socket_path, int clients, int requests, size_t size) {
+    uint8_t *payload = malloc(size ? size : 1);
+    double *latencies = malloc(sizeof(double) * clients * requests);
+    loadtest_client *c = calloc(clients, sizeof(loadtest_client));
+    pthread_t threads[clients];
+    uint8_t expected[HASH_SIZE];
+    word_t hash[8];
+
+    if (payload == NULL || latencies == NULL || c == NULL) {
+        fprintf(stderr, "Error: Unable to allocate memory for the load test\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = i * 31 + 7;
+    }
+    sha256_bits(payload, (uint64_t)size * 8, hash);
+    sha256_digest_bytes(hash, expected);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int started = 0;
+    for (; started < clients; started++) {
+        c[started] = (loadtest_client){.socket_path = socket_path,
+                                       .payload = payload,
+                                       .size = size,
+                                       .expected = expected,
+                                       .requests = requests,
+                                       .latencies = latencies + (size_t)started * requests};
+        if (pthread_create(&threads[started], NULL, loadtest_loop, &c[started]) != 0) {
+            fprintf(stderr, "Error: Unable to start client %d\n", started);
+            break;
+        }
+    }
+
+    size_t completed = 0;
+    int failed = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        /* Compact the latencies of all the clients */
+        memmove(latencies + completed, c[i].latencies, sizeof(double) * c[i].completed);
+        completed += c[i].completed;
+        failed += c[i].failed;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("Load test: %d clients, %d requests each, %zu bytes per request\n\n", started, requests,
+           size);
+    printf("  Completed: %zu\n", completed);
+    printf("  Failed:    %d\n", failed);
+
+    if (completed > 0) {
+        qsort(latencies, completed, sizeof(double), compare_double);
+        printf("  Requests/s: %.0f\n", completed / seconds);
+        printf("  Latency p50: %.1f us\n", percentile(latencies, completed, 50) * 1e6);
+        printf("  Latency p99: %.1f us\n", percentile(latencies, completed, 99) * 1e6);
+        printf("  Latency max: %.1f us\n", latencies[completed - 1] * 1e6);
+    }
+    printf("\n");
+
+    free(c);
+    free(latencies);
+    free(payload);
+
+    return failed == 0 && completed > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
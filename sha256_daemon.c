@@ -0,0 +1,628 @@
+/*
+ * Copyright (c) 2025 Fabio De Orazi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Long-running hashing daemon listening on a Unix domain socket.
+ *
+ * The main thread polls the listening socket and the idle connections. When
+ * a connection has a request to read, it is removed from the poll set and
+ * queued to the worker pool: a worker reads the request, hashes, replies and
+ * gives the connection back to the main thread (through a pipe that wakes up
+ * the poll), so a client keeps at most one request in flight and idle
+ * clients do not hold workers.
+ *
+ * A request has a deadline of DAEMON_IO_TIMEOUT seconds from when a worker
+ * starts reading it, so a client that stops (or trickles bytes) in the
+ * middle of a request holds a worker for at most that long. Sockets also
+ * have a send timeout for the response.
+ */
+
+// pipe2 and accept4
+#define _GNU_SOURCE
+
+#include "sha256_daemon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// Pause of the accepts when they fail, e.g. out of descriptors
+#define DAEMON_ACCEPT_BACKOFF_MS 100
+
+// Queue of connections with a request to read, and of connections to poll again
+static struct {
+    int ready[DAEMON_MAX_CLIENTS];
+    size_t ready_head;
+    size_t ready_count;
+    int idle[DAEMON_MAX_CLIENTS];
+    size_t idle_count;
+    int serving[DAEMON_MAX_WORKERS]; // connection of each worker, -1 if none
+    short stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} queue = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+
+static int wake_pipe[2];
+
+static volatile sig_atomic_t stop_requested = 0;
+
+/* Also wakes up the poll, in case the signal came right before it */
+static void on_stop_signal(int sig) {
+    int saved_errno = errno;
+
+    (void)sig;
+    stop_requested = 1;
+    if (write(wake_pipe[1], "", 1) < 0) {
+        // Pipe full, the poll is woken up anyway
+    }
+    errno = saved_errno;
+}
+
+ssize_t send_all(int fd, const void *buff, size_t length) {
+    size_t sent = 0;
+
+    while (sent < length) {
+        ssize_t n = send(fd, (const uint8_t *)buff + sent, length - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        sent += n;
+    }
+
+    return sent;
+}
+
+/* Returns the bytes received, less than length only if the peer closed */
+ssize_t recv_all(int fd, void *buff, size_t length) {
+    size_t got = 0;
+
+    while (got < length) {
+        ssize_t n = recv(fd, (uint8_t *)buff + got, length - got, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        got += n;
+    }
+
+    return got;
+}
+
+/* Sends header and payload, passing pass_fd as SCM_RIGHTS when >= 0 */
+int send_request(int sock, uint32_t type, const void *payload, uint64_t length, int pass_fd) {
+    daemon_request req = {.magic = DAEMON_MAGIC, .type = type, .length = length};
+    struct iovec iov = {.iov_base = &req, .iov_len = sizeof(req)};
+    union {
+        struct cmsghdr align;
+        char buff[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1};
+
+    if (pass_fd >= 0) {
+        msg.msg_control = control.buff;
+        msg.msg_controllen = sizeof(control.buff);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &pass_fd, sizeof(int));
+    }
+
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return -1;
+    }
+    /* Rest of a partially sent header, the descriptor went with the first byte */
+    if ((size_t)n < sizeof(req) &&
+        send_all(sock, (uint8_t *)&req + n, sizeof(req) - n) < 0) {
+        return -1;
+    }
+    if (length > 0 && send_all(sock, payload, length) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Milliseconds left before the deadline, 0 once it passed */
+static int ms_left(const struct timespec *deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    long ms = (deadline->tv_sec - now.tv_sec) * 1000 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+    return ms > 0 ? ms : 0;
+}
+
+/* Like recv_all, but fails with ETIMEDOUT once the deadline of the request
+ * passed, however the bytes are spread over time */
+static ssize_t recv_by(int fd, void *buff, size_t length, const struct timespec *deadline) {
+    size_t got = 0;
+
+    while (got < length) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int ready = poll(&pfd, 1, ms_left(deadline));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready == 0) {
+            errno = ETIMEDOUT;
+        }
+        if (ready <= 0) {
+            return -1;
+        }
+
+        ssize_t n = recv(fd, (uint8_t *)buff + got, length - got, MSG_DONTWAIT);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        got += n;
+    }
+
+    return got;
+}
+
+/* Receives the header and the descriptor passed with it, if any. Returns 1,
+ * 0 if the client closed the connection, -1 on errors */
+static int recv_header(int client, daemon_request *req, int *passed_fd,
+                       const struct timespec *deadline) {
+    struct iovec iov = {.iov_base = req, .iov_len = sizeof(*req)};
+    union {
+        struct cmsghdr align;
+        char buff[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg = {.msg_iov = &iov,
+                         .msg_iovlen = 1,
+                         .msg_control = control.buff,
+                         .msg_controllen = sizeof(control.buff)};
+
+    *passed_fd = -1;
+
+    /* The poll found the connection readable, the first bytes are there */
+    ssize_t n;
+    do {
+        n = recvmsg(client, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        return n;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(passed_fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    if ((size_t)n < sizeof(*req) &&
+        recv_by(client, (uint8_t *)req + n, sizeof(*req) - n, deadline) !=
+            (ssize_t)(sizeof(*req) - n)) {
+        return -1;
+    }
+
+    return 1;
+}
+
+static void hash_file(int fd, daemon_response *resp) {
+    word_t hash[8];
+    uint64_t message_bits = 0, blocks = 0;
+    struct stat st;
+
+    if (fstat(fd, &st) != 0) {
+        resp->status = RESP_ERROR;
+        resp->error = errno;
+        return;
+    }
+
+    /* Reads from pipes, sockets or devices may never end */
+    if (!S_ISREG(st.st_mode)) {
+        resp->status = RESP_ERROR;
+        resp->error = EINVAL;
+        return;
+    }
+
+    if (sha256_fd(fd, UINT64_MAX, hash, &message_bits, &blocks) != 0) {
+        resp->status = RESP_ERROR;
+        resp->error = errno;
+        return;
+    }
+
+    sha256_digest_bytes(hash, resp->digest);
+    resp->bytes = message_bits / 8;
+}
+
+static void hash_data(const uint8_t *data, uint64_t length, daemon_response *resp) {
+    /* Digests and pairs of digests are the common case, with their fast paths */
+    if (length == HASH_SIZE) {
+        sha256_32(data, resp->digest);
+    } else if (length == 2 * HASH_SIZE) {
+        sha256_64(data, resp->digest);
+    } else {
+        word_t hash[8];
+        sha256_bits(data, length * 8, hash);
+        sha256_digest_bytes(hash, resp->digest);
+    }
+    resp->bytes = length;
+}
+
+/**
+ * Reads a request from the client and replies.
+ *
+ * Returns 0 if the connection can be used for the next request, -1 if it
+ * has to be closed (client gone, or the stream can not be resynchronized).
+ */
+static int handle_request(int client) {
+    daemon_request req;
+    daemon_response resp = {.status = RESP_OK};
+    int passed_fd;
+    int keep = 0;
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += DAEMON_IO_TIMEOUT;
+
+    if (recv_header(client, &req, &passed_fd, &deadline) <= 0) {
+        if (passed_fd >= 0) {
+            close(passed_fd);
+        }
+        return -1;
+    }
+
+    if (req.magic != DAEMON_MAGIC) {
+        resp.status = RESP_BAD_REQUEST;
+        keep = -1;
+    } else if (req.type == REQ_HASH_FD) {
+        if (passed_fd < 0 || req.length != 0) {
+            resp.status = RESP_BAD_REQUEST;
+            keep = req.length != 0 ? -1 : 0;
+        } else {
+            hash_file(passed_fd, &resp);
+        }
+    } else if (req.type == REQ_HASH_PATH) {
+        char path[DAEMON_MAX_PATH + 1];
+
+        if (req.length == 0 || req.length > DAEMON_MAX_PATH) {
+            resp.status = RESP_BAD_REQUEST;
+            keep = -1;
+        } else if (recv_by(client, path, req.length, &deadline) != (ssize_t)req.length) {
+            keep = -1;
+            goto done;
+        } else {
+            path[req.length] = '\0';
+            /* Non-blocking, not to wait for a writer when it is a FIFO */
+            int fd = open(path, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+            if (fd < 0) {
+                resp.status = RESP_ERROR;
+                resp.error = errno;
+            } else {
+                hash_file(fd, &resp);
+                close(fd);
+            }
+        }
+    } else if (req.type == REQ_HASH_DATA) {
+        uint8_t *data = req.length <= DAEMON_MAX_DATA ? malloc(req.length ? req.length : 1) : NULL;
+
+        if (data == NULL) {
+            resp.status = req.length <= DAEMON_MAX_DATA ? RESP_ERROR : RESP_BAD_REQUEST;
+            resp.error = req.length <= DAEMON_MAX_DATA ? ENOMEM : EMSGSIZE;
+            keep = -1;
+        } else if (recv_by(client, data, req.length, &deadline) != (ssize_t)req.length) {
+            free(data);
+            keep = -1;
+            goto done;
+        } else {
+            hash_data(data, req.length, &resp);
+            free(data);
+        }
+    } else {
+        resp.status = RESP_BAD_REQUEST;
+        keep = -1;
+    }
+
+    if (send_all(client, &resp, sizeof(resp)) < 0) {
+        keep = -1;
+    }
+
+done:
+    if (passed_fd >= 0) {
+        close(passed_fd);
+    }
+
+    return keep;
+}
+
+static void *worker_loop(void *arg) {
+    int id = (int)(intptr_t)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&queue.lock);
+        while (queue.ready_count == 0 && !queue.stopping) {
+            pthread_cond_wait(&queue.cond, &queue.lock);
+        }
+        if (queue.stopping) {
+            pthread_mutex_unlock(&queue.lock);
+            return NULL;
+        }
+        int client = queue.ready[queue.ready_head];
+        queue.ready_head = (queue.ready_head + 1) % DAEMON_MAX_CLIENTS;
+        queue.ready_count--;
+        queue.serving[id] = client;
+        pthread_mutex_unlock(&queue.lock);
+
+        int keep = handle_request(client);
+
+        /* Back to the main thread to wait for the next request, or closed.
+         * Once out of serving the stop no longer touches it */
+        pthread_mutex_lock(&queue.lock);
+        queue.serving[id] = -1;
+        if (keep == 0) {
+            queue.idle[queue.idle_count++] = client;
+        }
+        pthread_mutex_unlock(&queue.lock);
+
+        if (keep != 0) {
+            close(client);
+            continue;
+        }
+
+        ssize_t n;
+        do {
+            n = write(wake_pipe[1], "", 1);
+        } while (n < 0 && errno == EINTR);
+    }
+}
+
+static int listen_socket(const char *socket_path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long\n");
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    /* Only a socket left by a previous instance is replaced: anything else at
+     * the path, or a socket with a daemon still listening, is left alone */
+    struct stat st;
+    if (lstat(socket_path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Error: %s exists and is not a socket\n", socket_path);
+            return -1;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int live = probe >= 0 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (live) {
+            fprintf(stderr, "Error: A daemon is already listening on %s\n", socket_path);
+            return -1;
+        }
+        unlink(socket_path);
+    }
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        perror("Error creating the socket");
+        return -1;
+    }
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, SOMAXCONN) != 0) {
+        perror("Error listening on the socket");
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/**
+ * Runs the daemon until SIGINT or SIGTERM. Connections are polled by this
+ * thread, requests are served by 'workers' threads.
+ */
+int run_daemon(const char *socket_path, int workers) {
+    int sock = listen_socket(socket_path);
+
+    if (sock < 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        perror("Error creating the wake up pipe");
+        close(sock);
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction sa = {.sa_handler = on_stop_signal};
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_t threads[DAEMON_MAX_WORKERS];
+
+    if (workers > DAEMON_MAX_WORKERS) {
+        workers = DAEMON_MAX_WORKERS;
+    }
+    for (int i = 0; i < workers; i++) {
+        queue.serving[i] = -1;
+    }
+
+    /* Workers inherit the stop signals blocked, so they interrupt the poll */
+    sigset_t stop_signals, previous;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &previous);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, worker_loop, (void *)(intptr_t)i) != 0) {
+            fprintf(stderr, "Error: Unable to start worker %d\n", i);
+            workers = i;
+            break;
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    printf("Listening on %s with %d workers\n", socket_path, workers);
+    fflush(stdout);
+
+    // Connections polled by this thread, and all the open ones
+    int polled[DAEMON_MAX_CLIENTS];
+    size_t polled_count = 0;
+    size_t connections = 0;
+    struct pollfd pfds[DAEMON_MAX_CLIENTS + 2];
+    struct timespec accept_resume = {0};
+
+    while (!stop_requested && workers > 0) {
+        int accepting = ms_left(&accept_resume) == 0;
+
+        pfds[0] = (struct pollfd){.fd = sock, .events = accepting ? POLLIN : 0};
+        pfds[1] = (struct pollfd){.fd = wake_pipe[0], .events = POLLIN};
+        for (size_t i = 0; i < polled_count; i++) {
+            pfds[i + 2] = (struct pollfd){.fd = polled[i], .events = POLLIN};
+        }
+
+        if (poll(pfds, polled_count + 2, accepting ? -1 : ms_left(&accept_resume)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Error polling the connections");
+            break;
+        }
+
+        /* Connections with a request (or closed) go to the workers */
+        size_t kept = 0;
+        for (size_t i = 0; i < polled_count; i++) {
+            if (pfds[i + 2].revents == 0) {
+                polled[kept++] = polled[i];
+                continue;
+            }
+            pthread_mutex_lock(&queue.lock);
+            queue.ready[(queue.ready_head + queue.ready_count) % DAEMON_MAX_CLIENTS] = polled[i];
+            queue.ready_count++;
+            pthread_cond_signal(&queue.cond);
+            pthread_mutex_unlock(&queue.lock);
+        }
+        polled_count = kept;
+
+        /* Connections served by the workers, closed ones are not given back */
+        if (pfds[1].revents & POLLIN) {
+            char drain[256];
+            while (read(wake_pipe[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        pthread_mutex_lock(&queue.lock);
+        memcpy(polled + polled_count, queue.idle, queue.idle_count * sizeof(int));
+        polled_count += queue.idle_count;
+        queue.idle_count = 0;
+        connections = polled_count + queue.ready_count;
+        pthread_mutex_unlock(&queue.lock);
+
+        if (pfds[0].revents & POLLIN) {
+            int client = accept4(sock, NULL, NULL, SOCK_CLOEXEC);
+            if (client < 0) {
+                /* The socket stays readable (EMFILE, ENFILE, ENOBUFS...), the
+                 * accepts pause instead of spinning on it */
+                if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED) {
+                    clock_gettime(CLOCK_MONOTONIC, &accept_resume);
+                    accept_resume.tv_nsec += DAEMON_ACCEPT_BACKOFF_MS * 1000000L;
+                    if (accept_resume.tv_nsec >= 1000000000) {
+                        accept_resume.tv_sec++;
+                        accept_resume.tv_nsec -= 1000000000;
+                    }
+                }
+                continue;
+            }
+            /* Counts only the connections seen by this thread, those in the
+             * workers can only decrease */
+            if (connections + (size_t)workers >= DAEMON_MAX_CLIENTS) {
+                close(client);
+                continue;
+            }
+            struct timeval timeout = {.tv_sec = DAEMON_IO_TIMEOUT};
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            polled[polled_count++] = client;
+        }
+    }
+
+    /* Workers waiting for a client return at once, a file being hashed is
+     * finished first */
+    pthread_mutex_lock(&queue.lock);
+    queue.stopping = 1;
+    for (int i = 0; i < workers; i++) {
+        if (queue.serving[i] >= 0) {
+            shutdown(queue.serving[i], SHUT_RDWR);
+        }
+    }
+    pthread_cond_broadcast(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+
+    for (int i = 0; i < workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (size_t i = 0; i < polled_count; i++) {
+        close(polled[i]);
+    }
+    for (size_t i = 0; i < queue.idle_count; i++) {
+        close(queue.idle[i]);
+    }
+    for (size_t i = 0; i < queue.ready_count; i++) {
+        close(queue.ready[(queue.ready_head + i) % DAEMON_MAX_CLIENTS]);
+    }
+
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+    close(sock);
+    unlink(socket_path);
+
+    printf("Daemon stopped\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#ifndef SHA256_DAEMON_H
+#define SHA256_DAEMON_H
+
+#include "sha256.h"
+#include <sys/types.h>
+
+/*
+ * Request protocol of the hashing daemon, over a Unix domain (stream) socket.
+ *
+ * A client sends a daemon_request header followed by 'length' bytes of
+ * payload and receives a daemon_response, then can send the next request on
+ * the same connection. Both ends are on the same host, so fields are in host
+ * byte order. A request has to be sent (and the response read) within
+ * DAEMON_IO_TIMEOUT, otherwise the connection is closed.
+ *
+ *   REQ_HASH_PATH   payload is the path of the file (without '\0')
+ *   REQ_HASH_FD     no payload, the open file descriptor is passed with the
+ *                   header as SCM_RIGHTS ancillary data. The file is hashed
+ *                   from the start and its offset is left unchanged
+ *   REQ_HASH_DATA   payload is the message to hash
+ *
+ * Files have to be regular files, anything else (pipes, sockets, devices) is
+ * answered with RESP_ERROR and EINVAL.
+ */
+
+#define DAEMON_MAGIC 0x53323536 // "S256"
+
+#define DAEMON_MAX_PATH 4096
+
+#define DAEMON_MAX_DATA (16 * 1024 * 1024) // 16 MB
+
+#define DAEMON_MAX_CLIENTS 1024
+
+#define DAEMON_IO_TIMEOUT 5 // seconds
+
+/* Each worker holds a connection out of the queues, so they stay well below
+ * the number of clients */
+#define DAEMON_MAX_WORKERS 256
+
+enum daemon_request_type { REQ_HASH_PATH = 1, REQ_HASH_FD = 2, REQ_HASH_DATA = 3 };
+
+enum daemon_status { RESP_OK = 0, RESP_ERROR = 1, RESP_BAD_REQUEST = 2 };
+
+typedef struct {
+    uint32_t magic;
+    uint32_t type;
+    uint64_t length;
+} daemon_request;
+
+typedef struct {
+    uint32_t status;
+    int32_t error; // errno of the failure when RESP_ERROR
+    uint64_t bytes;
+    uint8_t digest[HASH_SIZE];
+} daemon_response;
+
+ssize_t send_all(int fd, const void *buff, size_t length);
+
+ssize_t recv_all(int fd, void *buff, size_t length);
+
+int send_request(int sock, uint32_t type, const void *payload, uint64_t length, int pass_fd);
+
+int run_daemon(const char *socket_path, int workers);
+
+/* Client side (sha256_client.c) */
+
+int connect_daemon(const char *socket_path);
+
+int run_client(const char *socket_path, const char *path);
+
+int run_loadtest(const char *socket_path, int clients, int requests, size_t size);
+
+#endif
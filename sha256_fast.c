@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2025 Fabio De Orazi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Fast paths for fixed-size messages of 32 and 64 bytes (single digest and
+ * two concatenated digests), used for SHA256(SHA256(x)) and Merkle trees.
+ *
+ * With a known message length the padding is known in advance: for a 64-byte
+ * message the second block never changes, so its whole message schedule is
+ * folded into constants, and for a 32-byte message only the first 8 words of
+ * the schedule depend on the input.
+ */
+
+#include "sha256.h"
+#include <time.h>
+
+/* Same operations of maj_op, ch_op, sum_op_x and sigma_op_x, as macros so the
+ * compiler can inline them in the unrolled rounds */
+#define ROTR(w, n) (((w) >> (n)) | ((w) << (32 - (n))))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define SUM0(w) (ROTR(w, 2) ^ ROTR(w, 13) ^ ROTR(w, 22))
+#define SUM1(w) (ROTR(w, 6) ^ ROTR(w, 11) ^ ROTR(w, 25))
+#define SIGMA0(w) (ROTR(w, 7) ^ ROTR(w, 18) ^ ((w) >> 3))
+#define SIGMA1(w) (ROTR(w, 17) ^ ROTR(w, 19) ^ ((w) >> 10))
+
+/* K[t] + W[t] of the padding block of a 64-byte message (0x80, zeros and the
+ * 512-bit length): the block is the same for every message */
+static const word_t pad64_kw[64] = {
+    0xc28a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf374, 0x649b69c1, 0xf0fe4786, 0x0fe1edc6, 0x240cf254, 0x4fe9346f,
+    0x6cc984be, 0x61b9411e, 0x16f988fa, 0xf2c65152, 0xa88e5a6d, 0xb019fc65, 0xb9d99ec7,
+    0x9a1231c3, 0xe70eeaa0, 0xfdb1232b, 0xc7353eb0, 0x3069bad5, 0xcb976d5f, 0x5a0f118f,
+    0xdc1eeefd, 0x0a35b689, 0xde0b7a04, 0x58f4ca9d, 0xe15d5b16, 0x007f3e86, 0x37088980,
+    0xa507ea32, 0x6fab9537, 0x17406110, 0x0d8cd6f1, 0xcdaa3b6d, 0xc0bbbe37, 0x83613bda,
+    0xdb48a363, 0x0b02e931, 0x6fd15ca7, 0x521afaca, 0x31338431, 0x6ed41a95, 0x6d437890,
+    0xc39c91f2, 0x9eccabbd, 0xb5c9a0e6, 0x532fb63c, 0xd2c741c6, 0x07237ea3, 0xa4954b68,
+    0x4c191d76};
+
+static inline word_t load_be32(const uint8_t *p) {
+    return ((word_t)p[0] << 24) | ((word_t)p[1] << 16) | ((word_t)p[2] << 8) | (word_t)p[3];
+}
+
+/* Expand words 16-63 of the message schedule */
+static inline void expand_schedule(word_t w[64]) {
+    for (int t = 16; t < 64; t++) {
+        w[t] = SIGMA1(w[t - 2]) + w[t - 7] + SIGMA0(w[t - 15]) + w[t - 16];
+    }
+}
+
+/* 64 rounds with K[t] + W[t] already summed, then add to the hash value */
+static inline void compress_kw(word_t h[8], const word_t kw[64]) {
+    word_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+
+    for (int t = 0; t < 64; t++) {
+        word_t t1 = hh + SUM1(e) + CH(e, f, g) + kw[t];
+        word_t t2 = SUM0(a) + MAJ(a, b, c);
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += hh;
+}
+
+static inline void compress_schedule(word_t h[8], word_t w[64]) {
+    expand_schedule(w);
+    for (int t = 0; t < 64; t++) {
+        w[t] += sha256_k[t];
+    }
+    compress_kw(h, w);
+}
+
+/* Hash value of a 64-byte message, before serialization */
+static inline void hash_64(const uint8_t in[64], word_t h[8]) {
+    word_t w[64];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be32(in + i * 4);
+    }
+
+    memcpy(h, sha256_h0, sizeof(sha256_h0));
+    compress_schedule(h, w);
+    compress_kw(h, pad64_kw);
+}
+
+/* Hash value of a 32-byte message given as 8 big-endian words */
+static inline void hash_32_words(const word_t in[8], word_t h[8]) {
+    word_t w[64];
+
+    memcpy(w, in, sizeof(word_t) * 8);
+    w[8] = 0x80000000;
+    memset(w + 9, 0, sizeof(word_t) * 6);
+    w[15] = 256;
+
+    memcpy(h, sha256_h0, sizeof(sha256_h0));
+    compress_schedule(h, w);
+}
+
+void sha256_32(const uint8_t in[32], uint8_t out[32]) {
+    word_t words[8], h[8];
+
+    for (int i = 0; i < 8; i++) {
+        words[i] = load_be32(in + i * 4);
+    }
+    hash_32_words(words, h);
+    sha256_digest_bytes(h, out);
+}
+
+void sha256_64(const uint8_t in[64], uint8_t out[32]) {
+    word_t h[8];
+
+    hash_64(in, h);
+    sha256_digest_bytes(h, out);
+}
+
+/* The first digest is passed to the second round as words, without going
+ * through bytes */
+void sha256d_64(const uint8_t in[64], uint8_t out[32]) {
+    word_t first[8], h[8];
+
+    hash_64(in, first);
+    hash_32_words(first, h);
+    sha256_digest_bytes(h, out);
+}
+
+/* One word of every lane. With the vector extensions of GCC and Clang each
+ * operation on it is a SIMD instruction whatever the optimization flags
+ * (SSE2 halves on a baseline x86-64 build) */
+typedef word_t lanes_t __attribute__((vector_size(SHA256_LANES * sizeof(word_t))));
+
+/* The batch is also built for AVX2, picked at load time on CPUs that have it */
+#if defined(__x86_64__) && defined(__linux__)
+#define LANES_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define LANES_TARGETS
+#endif
+
+/**
+ * Runs the 64 rounds on SHA256_LANES independent messages at once. Every
+ * variable holds one word per lane, so each step is the same operation over
+ * all the lanes. Always inlined, to be built for the target of each clone of
+ * the caller.
+ */
+static inline __attribute__((always_inline)) void compress_lanes(lanes_t h[8], lanes_t w[64],
+                                                                 int prefolded) {
+    if (!prefolded) {
+        for (int t = 16; t < 64; t++) {
+            w[t] = SIGMA1(w[t - 2]) + w[t - 7] + SIGMA0(w[t - 15]) + w[t - 16];
+        }
+    }
+
+    lanes_t a = h[0], b = h[1], c = h[2], d = h[3];
+    lanes_t e = h[4], f = h[5], g = h[6], hh = h[7];
+
+    for (int t = 0; t < 64; t++) {
+        lanes_t t1 = hh + SUM1(e) + CH(e, f, g);
+        if (prefolded) {
+            t1 += pad64_kw[t];
+        } else {
+            t1 += sha256_k[t] + w[t];
+        }
+        lanes_t t2 = SUM0(a) + MAJ(a, b, c);
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += hh;
+}
+
+/**
+ * SHA256(x), or SHA256(SHA256(x)) when double_hash, of n contiguous 64-byte
+ * messages, 32-byte digests written contiguously to out.
+ *
+ * All the inputs of a group of lanes are loaded before its digests are
+ * stored, so out may overlap in as long as out <= in (used by merkle_root to
+ * reduce a tree level in place).
+ */
+LANES_TARGETS
+static void hash_64_batch(const uint8_t *in, uint8_t *out, size_t n, int double_hash) {
+    lanes_t w[64];
+    lanes_t h[8];
+    size_t i = 0;
+
+    for (; i + SHA256_LANES <= n; i += SHA256_LANES) {
+        const uint8_t *src = in + i * 64;
+
+        for (int t = 0; t < 16; t++) {
+            for (int l = 0; l < SHA256_LANES; l++) {
+                w[t][l] = load_be32(src + l * 64 + t * 4);
+            }
+        }
+        for (int j = 0; j < 8; j++) {
+            for (int l = 0; l < SHA256_LANES; l++) {
+                h[j][l] = sha256_h0[j];
+            }
+        }
+
+        compress_lanes(h, w, 0);
+        compress_lanes(h, w, 1);
+
+        if (double_hash) {
+            /* Second round: the first digest followed by constant padding */
+            for (int t = 0; t < 16; t++) {
+                for (int l = 0; l < SHA256_LANES; l++) {
+                    w[t][l] = t < 8 ? h[t][l] : (t == 8 ? 0x80000000 : (t == 15 ? 256 : 0));
+                }
+            }
+            for (int j = 0; j < 8; j++) {
+                for (int l = 0; l < SHA256_LANES; l++) {
+                    h[j][l] = sha256_h0[j];
+                }
+            }
+
+            compress_lanes(h, w, 0);
+        }
+
+        for (int l = 0; l < SHA256_LANES; l++) {
+            word_t lane[8];
+            for (int j = 0; j < 8; j++) {
+                lane[j] = h[j][l];
+            }
+            sha256_digest_bytes(lane, out + (i + l) * 32);
+        }
+    }
+
+    /* Remaining messages, fewer than a group of lanes */
+    for (; i < n; i++) {
+        if (double_hash) {
+            sha256d_64(in + i * 64, out + i * 32);
+        } else {
+            sha256_64(in + i * 64, out + i * 32);
+        }
+    }
+}
+
+void sha256_64_batch(const uint8_t *in, uint8_t *out, size_t n) {
+    hash_64_batch(in, out, n, 0);
+}
+
+void sha256d_64_batch(const uint8_t *in, uint8_t *out, size_t n) {
+    hash_64_batch(in, out, n, 1);
+}
+
+/**
+ * Merkle root of n 32-byte leaves, where each parent is SHA256(SHA256(left ||
+ * right)). On levels with an odd number of nodes the last one is paired with
+ * itself.
+ */
+void merkle_root(const uint8_t *leaves, size_t n, uint8_t root[32]) {
+    if (n == 0) {
+        memset(root, 0, HASH_SIZE);
+        return;
+    }
+
+    /* One extra node for the duplicate of the last one on odd levels */
+    uint8_t *level = malloc((n + 1) * HASH_SIZE);
+
+    if (level == NULL) {
+        fprintf(stderr, "Error: Unable to allocate memory for %zu tree nodes\n", n);
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(level, leaves, n * HASH_SIZE);
+
+    while (n > 1) {
+        if (n % 2) {
+            memcpy(level + n * HASH_SIZE, level + (n - 1) * HASH_SIZE, HASH_SIZE);
+            n++;
+        }
+        n /= 2;
+        sha256d_64_batch(level, level, n);
+    }
+
+    memcpy(root, level, HASH_SIZE);
+    free(level);
+}
+
+/* Merkle root computed with one sha256d_64 call per node */
+static void merkle_root_single(uint8_t *level, size_t n, uint8_t root[32]) {
+    while (n > 1) {
+        if (n % 2) {
+            memcpy(level + n * HASH_SIZE, level + (n - 1) * HASH_SIZE, HASH_SIZE);
+            n++;
+        }
+        n /= 2;
+        for (size_t i = 0; i < n; i++) {
+            sha256d_64(level + i * 64, level + i * HASH_SIZE);
+        }
+    }
+    memcpy(root, level, HASH_SIZE);
+}
+
+/* Merkle root computed through the general block functions of sha256.c, as
+ * if every node was an arbitrary message */
+static void merkle_root_generic(uint8_t *level, size_t n, uint8_t root[32]) {
+    unsigned char block[MESSAGE_BLOCK_SIZE];
+    word_t h[8];
+
+    while (n > 1) {
+        if (n % 2) {
+            memcpy(level + n * HASH_SIZE, level + (n - 1) * HASH_SIZE, HASH_SIZE);
+            n++;
+        }
+        n /= 2;
+        for (size_t i = 0; i < n; i++) {
+            memcpy(h, sha256_h0, sizeof(sha256_h0));
+            memcpy(block, level + i * 64, MESSAGE_BLOCK_SIZE);
+            elab_block(block, h, 0);
+            padding_block(block, 0, 512, 0);
+            elab_block(block, h, 1);
+
+            sha256_digest_bytes(h, block);
+            memcpy(h, sha256_h0, sizeof(sha256_h0));
+            padding_block(block, HASH_SIZE * 8, 256, 0);
+            elab_block(block, h, 1);
+            sha256_digest_bytes(h, level + i * HASH_SIZE);
+        }
+    }
+    memcpy(root, level, HASH_SIZE);
+}
+
+static double elapsed_seconds(struct timespec *start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Builds the Merkle tree of pseudo-random leaves with the generic path, the
+ * single fast path and the multi-lane batch, reporting nodes per second.
+ * Returns EXIT_FAILURE if the roots differ.
+ */
+int bench_merkle(size_t leaves) {
+    uint8_t *input = malloc(leaves * HASH_SIZE);
+    uint8_t *level = malloc((leaves + 1) * HASH_SIZE);
+
+    if (input == NULL || level == NULL) {
+        fprintf(stderr, "Error: Unable to allocate memory for %zu leaves\n", leaves);
+        exit(EXIT_FAILURE);
+    }
+
+    /* xorshift, so the leaves are the same at every run */
+    uint64_t x = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < leaves * HASH_SIZE; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        input[i] = x;
+    }
+
+    /* Internal nodes, counting the duplicates on odd levels */
+    size_t nodes = 0;
+    for (size_t n = leaves; n > 1; n = (n + 1) / 2) {
+        nodes += (n + 1) / 2;
+    }
+
+    const char *labels[] = {"generic", "sha256d_64", "batch"};
+    uint8_t roots[3][HASH_SIZE];
+
+    printf("Merkle tree: %zu leaves, %zu nodes, %d lanes\n\n", leaves, nodes, SHA256_LANES);
+    printf("%-12s%-14s%-16s%s\n", "Path", "Seconds", "Nodes/s", "Root");
+
+    for (int p = 0; p < 3; p++) {
+        struct timespec start;
+        memcpy(level, input, leaves * HASH_SIZE);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (p == 0) {
+            merkle_root_generic(level, leaves, roots[p]);
+        } else if (p == 1) {
+            merkle_root_single(level, leaves, roots[p]);
+        } else {
+            merkle_root(input, leaves, roots[p]);
+        }
+        double seconds = elapsed_seconds(&start);
+
+        printf("%-12s%-14.6f%-16.0f", labels[p], seconds, nodes / seconds);
+        for (int i = 0; i < HASH_SIZE; i++) {
+            printf("%02x", roots[p][i]);
+        }
+        printf("\n");
+    }
+
+    free(level);
+    free(input);
+
+    if (memcmp(roots[0], roots[1], HASH_SIZE) != 0 || memcmp(roots[0], roots[2], HASH_SIZE) != 0) {
+        fprintf(stderr, "Error: Merkle roots differ between paths\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
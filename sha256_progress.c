@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2025 Fabio De Orazi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Progress of a long hash, reported on stderr by a separate thread: the read
+ * loop only stores the bytes hashed so far in progress_bytes, the thread
+ * samples it at regular intervals.
+ *
+ * On a terminal a single line is redrawn with percent, current and average
+ * throughput and ETA; otherwise a JSON object per line is emitted, e.g.
+ *
+ * {"bytes":1073741824,"total":4294967296,"percent":25.00,"current_gbps":0.210,
+ *  "average_gbps":0.205,"eta_seconds":15,"done":false}
+ */
+
+#include "sha256.h"
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// Sampling interval on a terminal
+#define PROGRESS_TTY_INTERVAL_MS 500
+
+// Interval between JSON lines, when stderr is not a terminal
+#define PROGRESS_JSON_INTERVAL_MS 5000
+
+#define GB (1024.0 * 1024.0 * 1024.0)
+
+_Atomic uint64_t progress_bytes;
+
+static pthread_t progress_thread;
+static pthread_mutex_t progress_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t progress_cond;
+static short progress_running = 0;
+static short progress_tty = 0;
+static uint64_t progress_total;
+
+static double seconds_between(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void print_progress(uint64_t bytes, double current, double average, short done) {
+    double percent = progress_total ? 100.0 * bytes / progress_total : 0;
+    long eta = -1;
+
+    if (progress_total && average > 0 && bytes <= progress_total) {
+        eta = (long)((progress_total - bytes) / average);
+    }
+
+    if (progress_tty) {
+        fprintf(stderr, "\r\033[K");
+        if (progress_total) {
+            fprintf(stderr, "%6.2f%%  %.2f / %.2f GB", percent, bytes / GB, progress_total / GB);
+        } else {
+            fprintf(stderr, "%.2f GB", bytes / GB);
+        }
+        fprintf(stderr, "  current %.3f GB/s  average %.3f GB/s", current / GB, average / GB);
+        if (eta >= 0 && !done) {
+            fprintf(stderr, "  ETA %02ld:%02ld:%02ld", eta / 3600, (eta / 60) % 60, eta % 60);
+        }
+        if (done) {
+            fprintf(stderr, "\n");
+        }
+    } else {
+        fprintf(stderr, "{\"bytes\":%" PRIu64 ",\"total\":", bytes);
+        if (progress_total) {
+            fprintf(stderr, "%" PRIu64 ",\"percent\":%.2f", progress_total, percent);
+        } else {
+            fprintf(stderr, "null,\"percent\":null");
+        }
+        fprintf(stderr, ",\"current_gbps\":%.3f,\"average_gbps\":%.3f,\"eta_seconds\":",
+                current / GB, average / GB);
+        if (eta >= 0) {
+            fprintf(stderr, "%ld", done ? 0 : eta);
+        } else {
+            fprintf(stderr, "null");
+        }
+        fprintf(stderr, ",\"done\":%s}\n", done ? "true" : "false");
+    }
+    fflush(stderr);
+}
+
+/**
+ * Waits an interval (or the stop), samples the counter and prints. The final
+ * sample is always printed, also when the stop comes before the first one.
+ */
+static void *progress_loop(void *arg) {
+    (void)arg;
+    long interval_ms = progress_tty ? PROGRESS_TTY_INTERVAL_MS : PROGRESS_JSON_INTERVAL_MS;
+    struct timespec start, last, now, deadline;
+    uint64_t last_bytes = 0;
+    double current = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    last = start;
+
+    pthread_mutex_lock(&progress_lock);
+
+    for (;;) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += interval_ms / 1000;
+        deadline.tv_nsec += (interval_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while (progress_running &&
+               pthread_cond_timedwait(&progress_cond, &progress_lock, &deadline) == 0) {
+        }
+
+        short done = !progress_running;
+        uint64_t bytes = progress_bytes;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        double elapsed = seconds_between(&last, &now);
+        double total_elapsed = seconds_between(&start, &now);
+        if (elapsed > 0) {
+            current = (bytes - last_bytes) / elapsed;
+        }
+        double average = total_elapsed > 0 ? bytes / total_elapsed : 0;
+
+        print_progress(bytes, current, average, done);
+
+        if (done) {
+            break;
+        }
+
+        last = now;
+        last_bytes = bytes;
+    }
+
+    pthread_mutex_unlock(&progress_lock);
+
+    return NULL;
+}
+
+/**
+ * Starts the reporter thread. total_bytes is the expected size, 0 if not known
+ * (pipes), in which case percent and ETA are not reported.
+ */
+void progress_start(uint64_t total_bytes) {
+    pthread_condattr_t attr;
+
+    progress_bytes = 0;
+    progress_total = total_bytes;
+    progress_tty = isatty(STDERR_FILENO);
+    progress_running = 1;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&progress_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&progress_thread, NULL, progress_loop, NULL) != 0) {
+        fprintf(stderr, "Error: Unable to start the progress thread\n");
+        progress_running = 0;
+    }
+}
+
+/* Prints the final report and waits for the thread to exit */
+void progress_stop() {
+    pthread_mutex_lock(&progress_lock);
+    if (!progress_running) {
+        pthread_mutex_unlock(&progress_lock);
+        return;
+    }
+    progress_running = 0;
+    pthread_cond_signal(&progress_cond);
+    pthread_mutex_unlock(&progress_lock);
+
+    pthread_join(progress_thread, NULL);
+    pthread_cond_destroy(&progress_cond);
+}